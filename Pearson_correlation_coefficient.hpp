@@ -2,14 +2,13 @@
 #define JWM_STATISTICS
 
 #include "functional.hpp"
+#include "transform_iterator.hpp"
 
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/stats.hpp>
 #include <boost/accumulators/statistics/sum_kahan.hpp>
 #include <boost/accumulators/statistics/mean.hpp>
 
-#include <boost/iterator/transform_iterator.hpp>
-
 #include <Eigen/Dense>
 
 
@@ -17,10 +16,14 @@
 #include <array>
 #include <cassert>
 #include <cmath>
+#include <cstddef>
 #include <functional>
 #include <iterator>
+#include <memory>
 #include <numeric>
 #include <tuple>
+#include <type_traits>
+#include <vector>
 
 namespace jwm
 {    
@@ -174,10 +177,48 @@ namespace jwm
     }
     
     
+    // Whether the default-operator numeric algorithms below can run over raw
+    // memory: both sources must be contiguous, possibly seen through
+    // transform_iterator, and the accumulator arithmetic, so that the loop
+    // can be vectorized as a reduction.
+    template <typename I, typename J, typename T>
+    struct has_contiguous_fast_path : std::integral_constant<bool,
+        is_contiguous_view_source<I>::value &&
+        is_contiguous_view_source<J>::value &&
+        std::is_arithmetic<T>::value>
+    {};
+
+
+    namespace detail
+    {
+        template <typename Iterator0, typename Iterator1>
+        auto inner_product_nonempty(Iterator0 f0, Iterator0 l0, Iterator1 f1, std::false_type)
+        {
+            return std::inner_product(std::next(f0), l0, std::next(f1), *f0 * *f1);
+        }
+
+
+        template <typename Iterator0, typename Iterator1>
+        auto inner_product_nonempty(Iterator0 f0, Iterator0 l0, Iterator1 f1, std::true_type)
+        {
+            auto const x = make_contiguous_view(f0);
+            auto const y = make_contiguous_view(f1);
+            std::ptrdiff_t const n = l0 - f0;
+            auto result = x.f(x.p[0]) * y.f(y.p[0]);
+#pragma omp simd reduction(+:result)
+            for (std::ptrdiff_t i = 1; i < n; ++i)
+                result += x.f(x.p[i]) * y.f(y.p[i]);
+            return result;
+        }
+    }
+
+
     template <typename Iterator0, typename Iterator1>
     auto inner_product_nonempty(Iterator0 f0, Iterator0 l0, Iterator1 f1)
     {
-        return std::inner_product(std::next(f0), l0, std::next(f1), *f0 * *f1);
+        assert(f0 != l0);
+        using T = decltype(*f0 * *f1);
+        return detail::inner_product_nonempty(f0, l0, f1, has_contiguous_fast_path<Iterator0, Iterator1, T>());
     }
     
     
@@ -207,9 +248,9 @@ namespace jwm
         using std::sqrt;
         auto const n = std::distance(x1, xn);
         
-        auto fx1 = boost::make_transform_iterator(x1, bind2nd(std::minus<>(), mean_x)),
+        auto fx1 = make_transform_iterator(x1, bind2nd(std::minus<>(), mean_x)),
              fxn = fx1 + n;
-        auto fy1 = boost::make_transform_iterator(y1, bind2nd(std::minus<>(), mean_y)),
+        auto fy1 = make_transform_iterator(y1, bind2nd(std::minus<>(), mean_y)),
              fyn = fy1 + n;
 
         auto const numer = inner_product_nonempty(fx1, fxn, fy1);
@@ -227,9 +268,9 @@ namespace jwm
         using namespace std;
         auto const n = distance(x1, xn);
         
-        auto fx1 = boost::make_transform_iterator(x1, bind2nd(minus<>(), mean_x)),
+        auto fx1 = make_transform_iterator(x1, bind2nd(minus<>(), mean_x)),
              fxn = fx1 + n;
-        auto fy1 = boost::make_transform_iterator(y1, bind2nd(minus<>(), mean_y)),
+        auto fy1 = make_transform_iterator(y1, bind2nd(minus<>(), mean_y)),
              fyn = fy1 + n;
         
         auto const numer = inner_product_nonempty(fx1, fxn, fy1);
@@ -253,22 +294,72 @@ namespace jwm
     }
 
     
+    namespace detail
+    {
+        template <typename I, typename J, typename T>
+        std::tuple<T, T, T> three_way_inner_product(I f0, I l0, J f1, T a, T b, T c, std::false_type)
+        {
+            return jwm::three_way_inner_product(f0, l0, f1, a, b, c, std::plus<>(), std::multiplies<>());
+        }
+
+
+        // The transforms and the three products fuse into one loop.  As in
+        // the generic path, the products are formed in the element type and
+        // only then added to T.
+        template <typename I, typename J, typename T>
+        std::tuple<T, T, T> three_way_inner_product(I f0, I l0, J f1, T a, T b, T c, std::true_type)
+        {
+            std::ptrdiff_t const n = l0 - f0;
+            if (n == 0)
+                return std::make_tuple(a, b, c); // No element to take the address of.
+            auto const x = make_contiguous_view(f0);
+            auto const y = make_contiguous_view(f1);
+#pragma omp simd reduction(+:a, b, c)
+            for (std::ptrdiff_t i = 0; i < n; ++i)
+            {
+                auto const xi = x.f(x.p[i]);
+                auto const yi = y.f(y.p[i]);
+                a += xi * yi;
+                b += xi * xi;
+                c += yi * yi;
+            }
+            return std::make_tuple(a, b, c);
+        }
+    }
+
+
     template <typename I, typename J, typename T>
     std::tuple<T, T, T> three_way_inner_product(I f0, I l0, J f1, T a, T b, T c)
     {
-        return three_way_inner_product(f0, l0, f1, a, b, c, std::plus<>(), std::multiplies<>());
+        return detail::three_way_inner_product(f0, l0, f1, a, b, c, has_contiguous_fast_path<I, J, T>());
     }
     
     
+    /*
+     * -O3, given means:
+     * BM_Pearson_correlation_c/8              15 ns         15 ns   46962222
+     * BM_Pearson_correlation_c/64             62 ns         61 ns   10367011
+     * BM_Pearson_correlation_c/512           416 ns        406 ns    1817133
+     * BM_Pearson_correlation_c/4096         3640 ns       3578 ns     196023
+     * BM_Pearson_correlation_c/32768       29015 ns      27450 ns      24629
+     * BM_Pearson_correlation_c/262144     236161 ns     231451 ns       2924
+     * BM_Pearson_correlation_c/2097152   1961210 ns    1933128 ns        373
+     * BM_Pearson_correlation_c/8388608  17884063 ns   17596903 ns         46
+     */
+    // On contiguous data three_way_inner_product sees through the transform
+    // iterators, so the centring and the products fuse into one vectorized
+    // loop.  In the same run d was 1.1-1.7x slower from 64 elements up
+    // (1.6-6x with -march=native, least once the data outgrows cache) and
+    // slightly faster at 8.
     template <typename I, typename J, typename T>
     auto Pearson_correlation_coefficient_c(I x1, I xn, J y1, T mean_x, T mean_y)
     {
         assert(x1 != xn);
         using namespace std;
         
-        auto const fx1 = boost::make_transform_iterator(x1, bind2nd(minus<>(), mean_x)),
+        auto const fx1 = make_transform_iterator(x1, bind2nd(minus<>(), mean_x)),
                    fxn = fx1 + distance(x1, xn);
-        auto const fy1 = boost::make_transform_iterator(y1, bind2nd(minus<>(), mean_y));
+        auto const fy1 = make_transform_iterator(y1, bind2nd(minus<>(), mean_y));
         
         T numer, x_ss, y_ss;
         std::tie(numer, x_ss, y_ss) = three_way_inner_product(fx1, fxn, fy1, T(0), T(0), T(0));
@@ -330,9 +421,9 @@ namespace jwm
     {
         assert(x1 != xn);
         using namespace std;
-        auto const fx1 = boost::make_transform_iterator(x1, bind2nd(minus<>(), mean_x)),
+        auto const fx1 = make_transform_iterator(x1, bind2nd(minus<>(), mean_x)),
                    fxn = fx1 + distance(x1, xn);
-        auto const fy1 = boost::make_transform_iterator(y1, bind2nd(minus<>(), mean_y));
+        auto const fy1 = make_transform_iterator(y1, bind2nd(minus<>(), mean_y));
         
         auto const three_way = std::inner_product(fx1, fxn, fy1, std::array<T, 3>{}, make_vector_accumulation(std::plus<>()), three_way_product<T>());
         return three_way[1] / sqrt(three_way[0] * three_way[2]);
@@ -353,9 +444,9 @@ namespace jwm
     {
         assert(x1 != xn);
         using namespace std;
-        auto const fx1 = boost::make_transform_iterator(x1, bind2nd(minus<>(), mean_x)),
+        auto const fx1 = make_transform_iterator(x1, bind2nd(minus<>(), mean_x)),
                    fxn = fx1 + distance(x1, xn);
-        auto const fy1 = boost::make_transform_iterator(y1, bind2nd(minus<>(), mean_y));
+        auto const fy1 = make_transform_iterator(y1, bind2nd(minus<>(), mean_y));
         
         auto const three_way = std::inner_product(fx1, fxn, fy1, Vector3(0, 0, 0), std::plus<>(), three_way_product<T, Vector3>());
         return three_way[1] / sqrt(three_way[0] * three_way[2]);
@@ -390,9 +481,9 @@ namespace jwm
         assert(x1 != xn);
         using namespace std;
         auto const n = distance(x1, xn);        
-        auto const fx1 = boost::make_transform_iterator(x1, bind2nd(minus<>(), mean_x)),
+        auto const fx1 = make_transform_iterator(x1, bind2nd(minus<>(), mean_x)),
                    fxn = fx1 + n;
-        auto const fy1 = boost::make_transform_iterator(y1, bind2nd(minus<>(), mean_y));
+        auto const fy1 = make_transform_iterator(y1, bind2nd(minus<>(), mean_y));
         
         using namespace boost::accumulators;
         using kahan_accumulator = accumulator_set<T, stats<tag::sum_kahan>>;
@@ -427,9 +518,9 @@ namespace jwm
     {
         assert(x1 != xn);
         using namespace std;
-        auto fx1 = boost::make_transform_iterator(x1, bind2nd(minus<>(), mean_x)),
+        auto fx1 = make_transform_iterator(x1, bind2nd(minus<>(), mean_x)),
              fxn = fx1 + distance(x1, xn);
-        auto fy1 = boost::make_transform_iterator(y1, bind2nd(minus<>(), mean_y));
+        auto fy1 = make_transform_iterator(y1, bind2nd(minus<>(), mean_y));
         
         using namespace boost::accumulators;
         using kahan_accumulator = accumulator_set<T, stats<tag::sum_kahan>>;
@@ -486,9 +577,9 @@ namespace jwm
     {
         assert(x1 != xn);
         using namespace std;
-        auto const fx1 = boost::make_transform_iterator(x1, bind2nd(minus<>(), mean_x)),
+        auto const fx1 = make_transform_iterator(x1, bind2nd(minus<>(), mean_x)),
                    fxn = fx1 + distance(x1, xn);
-        auto const fy1 = boost::make_transform_iterator(y1, bind2nd(minus<>(), mean_y));
+        auto const fy1 = make_transform_iterator(y1, bind2nd(minus<>(), mean_y));
         
         using namespace boost::accumulators;
         using kahan_accumulator = accumulator_set<T, stats<tag::sum_kahan>>;
@@ -514,9 +605,254 @@ namespace jwm
         }; // or Boost accumulator
         auto const mean_x = f(x1, xn), 
                    mean_y = f(y1, y1 + n);
-        auto const Pcc = Pearson_correlation_coefficient_d(x1, xn, y1, mean_x, mean_y);
+        auto const Pcc = Pearson_correlation_coefficient_c(x1, xn, y1, mean_x, mean_y);
         return std::make_tuple(Pcc, mean_x, mean_y);
-    }    
+    }
+
+
+    namespace detail
+    {
+        // The pair (x(i), y(i)) for i in [0, n), read through accessors so
+        // that one kernel serves every interleaved layout.  When the layout
+        // is fixed at compile time, the loads become vectorized
+        // deinterleaving shuffles.
+        template <typename T, typename X, typename Y>
+        std::tuple<T, T, T> Pearson_correlation_coefficient_interleaved(std::ptrdiff_t n, X x, Y y)
+        {
+            assert(n != 0);
+            using std::sqrt;
+
+            T sum_x{0}, sum_y{0};
+#pragma omp simd reduction(+:sum_x, sum_y)
+            for (std::ptrdiff_t i = 0; i < n; ++i)
+            {
+                sum_x += x(i);
+                sum_y += y(i);
+            }
+            T const mean_x = sum_x / n, mean_y = sum_y / n;
+
+            T xy{0}, xx{0}, yy{0};
+#pragma omp simd reduction(+:xy, xx, yy)
+            for (std::ptrdiff_t i = 0; i < n; ++i)
+            {
+                T const xi = x(i) - mean_x, yi = y(i) - mean_y;
+                xy += xi * yi;
+                xx += xi * xi;
+                yy += yi * yi;
+            }
+            return std::make_tuple(xy / sqrt(xx * yy), mean_x, mean_y);
+        }
+    }
+
+
+    // [first, last) is a flat buffer of records of stride elements, each
+    // beginning with an x, y pair: x0, y0, ..., x1, y1, ...
+    // The default stride reads a plain double[2n].
+    template <typename I>
+    auto Pearson_correlation_coefficient_interleaved(I first, I last, std::ptrdiff_t stride = 2)
+    {
+        static_assert(is_contiguous_iterator<I>::value, "interleaved data must be contiguous");
+        assert(first != last);
+        assert(stride >= 2);
+        assert((last - first) % stride == 0);
+        using T = typename std::iterator_traits<I>::value_type;
+
+        auto const p = std::addressof(*first);
+        auto const n = (last - first) / stride;
+        if (stride == 2)
+            return detail::Pearson_correlation_coefficient_interleaved<T>(n,
+                [p](std::ptrdiff_t i) { return p[2 * i]; },
+                [p](std::ptrdiff_t i) { return p[2 * i + 1]; });
+        return detail::Pearson_correlation_coefficient_interleaved<T>(n,
+            [p, stride](std::ptrdiff_t i) { return p[stride * i]; },
+            [p, stride](std::ptrdiff_t i) { return p[stride * i + 1]; });
+    }
+
+
+    // A random-access range of records, such as std::pair<T, T> or a struct
+    // {T x, y;}, with x and y named by member pointers.
+    template <typename I, typename T, typename V>
+    auto Pearson_correlation_coefficient(I first, I last, T V::*x, T V::*y)
+    {
+        assert(first != last);
+        return detail::Pearson_correlation_coefficient_interleaved<T>(last - first,
+            [first, x](std::ptrdiff_t i) { return first[i].*x; },
+            [first, y](std::ptrdiff_t i) { return first[i].*y; });
+    }
+
+
+    // Two Eigen vectors of the same size, such as columns or rows of a
+    // matrix, an Eigen::Map (optionally strided) or an Eigen::Ref; a column
+    // may be correlated with a row.  The reductions run on Eigen
+    // expressions, so nothing is copied.
+    template <typename DerivedX, typename DerivedY>
+    auto Pearson_correlation_coefficient(Eigen::DenseBase<DerivedX> const &x, Eigen::DenseBase<DerivedY> const &y)
+    {
+        eigen_assert(x.size() != 0);
+        eigen_assert(x.size() == y.size());
+        eigen_assert((x.rows() == 1 || x.cols() == 1) && (y.rows() == 1 || y.cols() == 1));
+        using std::sqrt;
+        using T = typename DerivedX::Scalar;
+
+        T const mean_x = x.mean(),
+                mean_y = y.mean();
+        // dot transposes as needed, so the shapes need not match.
+        auto const dx = (x.derived().array() - mean_x).matrix();
+        auto const dy = (y.derived().array() - mean_y).matrix();
+        T const xy = dx.dot(dy),
+                xx = dx.squaredNorm(),
+                yy = dy.squaredNorm();
+        return std::make_tuple(xy / sqrt(xx * yy), mean_x, mean_y);
+    }
+
+
+    // Correlate every column of X with the vector y, which has as many
+    // elements as X has rows.  Returns the coefficients, the column means of
+    // X and the mean of y.
+    template <typename DerivedX, typename DerivedY>
+    auto columnwise_Pearson_correlation_coefficient(Eigen::DenseBase<DerivedX> const &X, Eigen::DenseBase<DerivedY> const &y)
+    {
+        eigen_assert(X.rows() != 0);
+        eigen_assert(y.size() == X.rows());
+        eigen_assert(y.rows() == 1 || y.cols() == 1);
+        using T = typename DerivedX::Scalar;
+        using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+        using RowVector = Eigen::Matrix<T, 1, Eigen::Dynamic>;
+
+        T const mean_y = y.mean();
+        auto const dy = (y.derived().array() - mean_y).matrix();
+        T const yy = dy.squaredNorm();
+
+        Vector Pcc(X.cols());
+        RowVector mean_x(X.cols());
+        for (Eigen::Index j = 0; j != X.cols(); ++j)
+        {
+            auto const x = X.derived().col(j);
+            mean_x[j] = x.mean();
+            auto const dx = (x.array() - mean_x[j]).matrix();
+            Pcc[j] = dx.dot(dy) / std::sqrt(dx.squaredNorm() * yy);
+        }
+        return std::make_tuple(Pcc, mean_x, mean_y);
+    }
+
+
+    // The sufficient statistics of a bivariate sample: its size, means and
+    // centred sums of products.  Samples are merged with the pairwise update
+    // of Chan, Golub and LeVeque, so pieces of one series can be summarized
+    // separately and combined exactly.
+    template <typename T>
+    struct comoments
+    {
+        std::ptrdiff_t n;
+        T mean_x, mean_y, xx, xy, yy;
+    };
+
+
+    template <typename I, typename J>
+    auto make_comoments(I x1, I xn, J y1)
+    {
+        assert(x1 != xn);
+        using T = typename std::iterator_traits<I>::value_type;
+        static_assert(std::is_floating_point<T>::value, "comoments need floating-point means");
+        auto const n = std::distance(x1, xn);
+        T const mean_x = std::accumulate(x1, xn, T{0}) / n,
+                mean_y = std::accumulate(y1, std::next(y1, n), T{0}) / n;
+        auto const fx1 = make_transform_iterator(x1, bind2nd(std::minus<>(), mean_x)),
+                   fxn = make_transform_iterator(xn, bind2nd(std::minus<>(), mean_x));
+        auto const fy1 = make_transform_iterator(y1, bind2nd(std::minus<>(), mean_y));
+        T xy, xx, yy;
+        std::tie(xy, xx, yy) = three_way_inner_product(fx1, fxn, fy1, T{0}, T{0}, T{0});
+        return comoments<T>{n, mean_x, mean_y, xx, xy, yy};
+    }
+
+
+    template <typename T>
+    comoments<T> merge(comoments<T> const &a, comoments<T> const &b)
+    {
+        if (a.n == 0)
+            return b;
+        if (b.n == 0)
+            return a;
+        auto const n = a.n + b.n;
+        T const dx = b.mean_x - a.mean_x,
+                dy = b.mean_y - a.mean_y,
+                w = T(a.n) * T(b.n) / T(n);
+        return comoments<T>{n,
+                            a.mean_x + dx * b.n / n,
+                            a.mean_y + dy * b.n / n,
+                            a.xx + b.xx + dx * dx * w,
+                            a.xy + b.xy + dx * dy * w,
+                            a.yy + b.yy + dy * dy * w};
+    }
+
+
+    template <typename T>
+    std::tuple<T, T, T> Pearson_correlation_coefficient(comoments<T> const &m)
+    {
+        using std::sqrt;
+        return std::make_tuple(m.xy / sqrt(m.xx * m.yy), m.mean_x, m.mean_y);
+    }
+
+
+    /**
+     * Estimate the correlation from blocks of pairs visited in random order,
+     * stopping once the Fisher-z confidence interval for r is no wider than
+     * epsilon.  z is the normal quantile of the interval (1.96 for 95%).
+     *
+     * Returns (r, mean_x, mean_y, m) where m is the number of pairs read; if
+     * m == distance(x1, xn) every block was read and the result is exact.
+     * Inputs of fewer than four blocks are summarized exactly in one
+     * make_comoments call.  The data must be floating-point.
+     *
+     * The interval treats the pairs read as a simple random sample, which is
+     * only approximately true of whole blocks; keep the blocks small relative
+     * to any structure in the data.  It is also re-checked after every block
+     * (optional stopping), so its real coverage is below the nominal one.
+     *
+     * The accumulators have the value type of I; epsilon and z are converted
+     * to it.
+     */
+    template <typename I, typename J, typename URBG>
+    auto Pearson_correlation_coefficient_approximate(I x1, I xn, J y1,
+        typename std::iterator_traits<I>::value_type epsilon, URBG &&g,
+        typename std::iterator_traits<I>::value_type z = 1.959964, std::ptrdiff_t block = 4096)
+    {
+        assert(x1 != xn);
+        assert(block > 0);
+        using std::sqrt;
+        using std::atanh;
+        using std::tanh;
+        using T = typename std::iterator_traits<I>::value_type;
+        static_assert(std::is_floating_point<T>::value, "the approximation needs floating-point data");
+
+        std::ptrdiff_t const n = std::distance(x1, xn);
+        auto const blocks = (n + block - 1) / block;
+        if (blocks < 4)
+        {
+            auto const exact = Pearson_correlation_coefficient(make_comoments(x1, xn, y1));
+            return std::make_tuple(std::get<0>(exact), std::get<1>(exact), std::get<2>(exact), n);
+        }
+
+        std::vector<std::ptrdiff_t> order(blocks);
+        std::iota(std::begin(order), std::end(order), 0);
+        std::shuffle(std::begin(order), std::end(order), std::forward<URBG>(g));
+
+        comoments<T> m{0, T{0}, T{0}, T{0}, T{0}, T{0}};
+        for (auto const b : order)
+        {
+            auto const first = b * block, last = std::min(first + block, n);
+            m = merge(m, make_comoments(x1 + first, x1 + last, y1 + first));
+            if (m.n == n || m.n <= 3)
+                continue;
+            auto const r = std::get<0>(Pearson_correlation_coefficient(m));
+            if (!(std::abs(r) < T{1}))
+                continue; // Undefined or degenerate: keep reading.
+            auto const centre = atanh(r), half_width = z / sqrt(T(m.n - 3));
+            if (tanh(centre + half_width) - tanh(centre - half_width) <= epsilon)
+                break;
+        }
+        return std::make_tuple(m.xy / sqrt(m.xx * m.yy), m.mean_x, m.mean_y, m.n);
+    }
 }
 
 #endif
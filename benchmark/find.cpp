@@ -1,6 +1,7 @@
 #include <benchmark/benchmark.h>
 
 #include "../find.hpp"
+#include "../functional.hpp"
 
 #include <algorithm>
 #include <functional>
@@ -63,7 +64,22 @@ static void BM_find_if_unguarded_lambda(benchmark::State &s)
 }
 
 
+static void BM_find_if_unguarded_jwm_bind(benchmark::State &s)
+{
+    vector<int> v(s.range(0));
+    iota(begin(v), end(v), 0);
+    int x = v.back();
+    auto const pred = jwm::bind2nd(equal_to<>(), x);
+    
+    while (s.KeepRunning())
+    {
+        benchmark::DoNotOptimize(jwm::find_if_unguarded(begin(v), pred));
+    }
+}
+
+
 BENCHMARK(BM_find_if_unguarded_bind)->Range(8, 8<<20);
 BENCHMARK(BM_find_if_unguarded_lambda)->Range(8, 8<<20);
+BENCHMARK(BM_find_if_unguarded_jwm_bind)->Range(8, 8<<20);
 
 BENCHMARK_MAIN();
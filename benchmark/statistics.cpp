@@ -2,6 +2,10 @@
 
 #include "../Pearson_correlation_coefficient.hpp"
 
+#include "../test/correlated_sample.hpp"
+
+#include <random>
+
 static void BM_Pearson_correlation(benchmark::State &s)
 {
     std::vector<double> x(s.range(0)), y(s.range(0));
@@ -12,6 +16,133 @@ static void BM_Pearson_correlation(benchmark::State &s)
     }
 }
 
+
+// c and d with the same given means, so that only the reduction differs.
+static void BM_Pearson_correlation_c(benchmark::State &s)
+{
+    std::vector<double> x(s.range(0)), y(s.range(0));
+
+    while (s.KeepRunning())
+    {
+        benchmark::DoNotOptimize(jwm::Pearson_correlation_coefficient_c(begin(x), end(x), begin(y), 0.0, 0.0));
+    }
+}
+
+
+static void BM_Pearson_correlation_d(benchmark::State &s)
+{
+    std::vector<double> x(s.range(0)), y(s.range(0));
+
+    while (s.KeepRunning())
+    {
+        benchmark::DoNotOptimize(jwm::Pearson_correlation_coefficient_d(begin(x), end(x), begin(y), 0.0, 0.0));
+    }
+}
+
+
+// Correlating two columns of a matrix in place...
+static void BM_Pearson_correlation_Eigen_columns(benchmark::State &s)
+{
+    Eigen::MatrixXd m = Eigen::MatrixXd::Zero(s.range(0), 2);
+
+    while (s.KeepRunning())
+    {
+        benchmark::DoNotOptimize(jwm::Pearson_correlation_coefficient(m.col(0), m.col(1)));
+    }
+}
+
+
+// ...versus copying them out first into the same overload, so that the
+// difference is only the copy...
+static void BM_Pearson_correlation_Eigen_copy(benchmark::State &s)
+{
+    Eigen::MatrixXd m = Eigen::MatrixXd::Zero(s.range(0), 2);
+
+    while (s.KeepRunning())
+    {
+        Eigen::VectorXd const x = m.col(0), y = m.col(1);
+        benchmark::DoNotOptimize(jwm::Pearson_correlation_coefficient(x, y));
+    }
+}
+
+
+// ...or into vectors for the iterator entry point, which also differs in
+// its (Kahan) means.
+static void BM_Pearson_correlation_Eigen_copy_iterators(benchmark::State &s)
+{
+    Eigen::MatrixXd m = Eigen::MatrixXd::Zero(s.range(0), 2);
+
+    while (s.KeepRunning())
+    {
+        std::vector<double> x(m.col(0).data(), m.col(0).data() + m.rows()),
+                            y(m.col(1).data(), m.col(1).data() + m.rows());
+        benchmark::DoNotOptimize(jwm::Pearson_correlation_coefficient(begin(x), end(x), begin(y)));
+    }
+}
+
+
+static void BM_Pearson_correlation_interleaved(benchmark::State &s)
+{
+    std::vector<double> xy(2 * s.range(0));
+
+    while (s.KeepRunning())
+    {
+        benchmark::DoNotOptimize(jwm::Pearson_correlation_coefficient_interleaved(begin(xy), end(xy)));
+    }
+}
+
+
+static void BM_Pearson_correlation_pairs(benchmark::State &s)
+{
+    using P = std::pair<double, double>;
+    std::vector<P> xy(s.range(0));
+
+    while (s.KeepRunning())
+    {
+        benchmark::DoNotOptimize(jwm::Pearson_correlation_coefficient(begin(xy), end(xy), &P::first, &P::second));
+    }
+}
+
+
+// The comoment kernel over all the data: what the approximate mode does
+// per block, so that the difference is only what early termination saves.
+static void BM_Pearson_correlation_comoments(benchmark::State &s)
+{
+    std::vector<double> x, y;
+    correlated_sample(x, y, s.range(0));
+
+    while (s.KeepRunning())
+    {
+        benchmark::DoNotOptimize(jwm::Pearson_correlation_coefficient(jwm::make_comoments(begin(x), end(x), begin(y))));
+    }
+}
+
+
+static void BM_Pearson_correlation_approximate(benchmark::State &s)
+{
+    std::vector<double> x, y;
+    correlated_sample(x, y, s.range(0));
+    std::mt19937_64 g(1);
+    std::ptrdiff_t touched = 0;
+
+    while (s.KeepRunning())
+    {
+        auto const r = jwm::Pearson_correlation_coefficient_approximate(begin(x), end(x), begin(y), 0.01, g);
+        touched = std::get<3>(r);
+        benchmark::DoNotOptimize(r);
+    }
+    s.counters["touched"] = double(touched) / x.size();
+}
+
 BENCHMARK(BM_Pearson_correlation)->Range(8, 8<<20);
+BENCHMARK(BM_Pearson_correlation_c)->Range(8, 8<<20);
+BENCHMARK(BM_Pearson_correlation_d)->Range(8, 8<<20);
+BENCHMARK(BM_Pearson_correlation_Eigen_columns)->Range(8, 8<<20);
+BENCHMARK(BM_Pearson_correlation_Eigen_copy)->Range(8, 8<<20);
+BENCHMARK(BM_Pearson_correlation_Eigen_copy_iterators)->Range(8, 8<<20);
+BENCHMARK(BM_Pearson_correlation_interleaved)->Range(8, 8<<20);
+BENCHMARK(BM_Pearson_correlation_pairs)->Range(8, 8<<20);
+BENCHMARK(BM_Pearson_correlation_comoments)->Range(8, 8<<20);
+BENCHMARK(BM_Pearson_correlation_approximate)->Range(8, 8<<20);
 
 BENCHMARK_MAIN();
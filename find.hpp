@@ -1,6 +1,8 @@
 #ifndef JWM_FIND_HPP
 #define JWM_FIND_HPP
 
+#include "functional.hpp"
+
 #include <functional>
 #include <iterator>
 
@@ -18,8 +20,7 @@ namespace jwm
     template <typename Iterator, typename T>
     Iterator find_unguarded(Iterator first, T &&x)
     {
-        using namespace std;
-        auto const pred = bind(equal_to<>(), placeholders::_1, forward<T>(x));
+        auto const pred = jwm::bind2nd(std::equal_to<>(), std::forward<T>(x));
         return find_if_unguarded(first, pred);
     }
 }
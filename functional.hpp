@@ -2,6 +2,7 @@
 #define JWM_FUNCTIONAL_HPP
 
 #include <functional>
+#include <type_traits>
 #include <utility>
 
 namespace jwm
@@ -10,24 +11,128 @@ namespace jwm
 struct identity
 {
     template <typename T>
-    T &&operator()(T &&x) const
+    constexpr T &&operator()(T &&x) const noexcept
     {
         return std::forward<T>(x);
     }
 };
 
 
+namespace detail
+{
+    // Stores a function object, inheriting from it when it is empty so that
+    // binders of stateless functions like std::minus<> cost nothing.
+    // I distinguishes otherwise identical bases within one class.
+    template <typename F, int I = 0, bool = std::is_empty<F>::value && !std::is_final<F>::value>
+    struct function_storage : private F
+    {
+        constexpr function_storage(F const &f) noexcept(std::is_nothrow_copy_constructible<F>::value) : F(f) {}
+        constexpr function_storage(F &&f) noexcept(std::is_nothrow_move_constructible<F>::value) : F(std::move(f)) {}
+
+        constexpr F const &function() const noexcept { return *this; }
+    };
+
+
+    template <typename F, int I>
+    struct function_storage<F, I, false>
+    {
+        F f;
+
+        constexpr function_storage(F const &f) noexcept(std::is_nothrow_copy_constructible<F>::value) : f(f) {}
+        constexpr function_storage(F &&f) noexcept(std::is_nothrow_move_constructible<F>::value) : f(std::move(f)) {}
+
+        constexpr F const &function() const noexcept { return f; }
+    };
+}
+
+
+// A replacement for std::bind(f, x, _1) that the optimizer can see through.
+template <typename F, typename T>
+struct binder1st : private detail::function_storage<F>
+{
+    T x;
+
+    template <typename G, typename U>
+    constexpr binder1st(G &&f, U &&x) : detail::function_storage<F>(std::forward<G>(f)), x(std::forward<U>(x)) {}
+
+    template <typename U>
+    constexpr auto operator()(U &&y) const noexcept(noexcept(std::declval<F const &>()(std::declval<T const &>(), std::forward<U>(y))))
+        -> decltype(std::declval<F const &>()(std::declval<T const &>(), std::forward<U>(y)))
+    {
+        return this->function()(x, std::forward<U>(y));
+    }
+};
+
+
+// A replacement for std::bind(f, _1, x) that the optimizer can see through.
 template <typename F, typename T>
-auto bind1st(F &&f, T &&x)
+struct binder2nd : private detail::function_storage<F>
 {
-    return std::bind(std::forward<F>(f), std::forward<T>(x), std::placeholders::_1);
+    T x;
+
+    template <typename G, typename U>
+    constexpr binder2nd(G &&f, U &&x) : detail::function_storage<F>(std::forward<G>(f)), x(std::forward<U>(x)) {}
+
+    template <typename U>
+    constexpr auto operator()(U &&y) const noexcept(noexcept(std::declval<F const &>()(std::forward<U>(y), std::declval<T const &>())))
+        -> decltype(std::declval<F const &>()(std::forward<U>(y), std::declval<T const &>()))
+    {
+        return this->function()(std::forward<U>(y), x);
+    }
+};
+
+
+// f(g(x...))
+template <typename F, typename G, bool = std::is_same<F, G>::value && std::is_empty<F>::value && !std::is_final<F>::value>
+struct composition : private detail::function_storage<F, 0>, private detail::function_storage<G, 1>
+{
+    template <typename H, typename K>
+    constexpr composition(H &&f, K &&g) : detail::function_storage<F, 0>(std::forward<H>(f)), detail::function_storage<G, 1>(std::forward<K>(g)) {}
+
+    template <typename... Us>
+    constexpr auto operator()(Us &&...xs) const noexcept(noexcept(std::declval<F const &>()(std::declval<G const &>()(std::forward<Us>(xs)...))))
+        -> decltype(std::declval<F const &>()(std::declval<G const &>()(std::forward<Us>(xs)...)))
+    {
+        return detail::function_storage<F, 0>::function()(detail::function_storage<G, 1>::function()(std::forward<Us>(xs)...));
+    }
+};
+
+
+// f(f(x...)) for an empty F: two bases of the same type cannot share an
+// address, so one stateless F serves as both.
+template <typename F>
+struct composition<F, F, true> : private detail::function_storage<F>
+{
+    template <typename H, typename K>
+    constexpr composition(H &&f, K &&) : detail::function_storage<F>(std::forward<H>(f)) {}
+
+    template <typename... Us>
+    constexpr auto operator()(Us &&...xs) const noexcept(noexcept(std::declval<F const &>()(std::declval<F const &>()(std::forward<Us>(xs)...))))
+        -> decltype(std::declval<F const &>()(std::declval<F const &>()(std::forward<Us>(xs)...)))
+    {
+        return this->function()(this->function()(std::forward<Us>(xs)...));
+    }
+};
+
+
+template <typename F, typename T>
+constexpr auto bind1st(F &&f, T &&x)
+{
+    return binder1st<std::decay_t<F>, std::decay_t<T>>(std::forward<F>(f), std::forward<T>(x));
 }
 
 
 template <typename F, typename T>
-auto bind2nd(F &&f, T &&x)
+constexpr auto bind2nd(F &&f, T &&x)
+{
+    return binder2nd<std::decay_t<F>, std::decay_t<T>>(std::forward<F>(f), std::forward<T>(x));
+}
+
+
+template <typename F, typename G>
+constexpr auto compose(F &&f, G &&g)
 {
-    return std::bind(std::forward<F>(f), std::placeholders::_1, std::forward<T>(x));
+    return composition<std::decay_t<F>, std::decay_t<G>>(std::forward<F>(f), std::forward<G>(g));
 }
 
 }
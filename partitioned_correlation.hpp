@@ -0,0 +1,465 @@
+#ifndef JWM_PARTITIONED_CORRELATION_HPP
+#define JWM_PARTITIONED_CORRELATION_HPP
+
+// Map-reduce correlation over column files on one Linux machine.
+//
+// A column file is a raw array of T in native byte order.  The parent maps
+// the columns and cuts the rows into one contiguous partition per worker
+// process; each worker is pinned to the CPUs of one NUMA node and sends its
+// partial moments back through a pipe, and the parent merges them.
+//
+// The workers are forked and then allocate memory, which is only safe if the
+// calling process is single-threaded: call these before starting any
+// threads, including an OpenMP parallel region.
+
+#include "Pearson_correlation_coefficient.hpp"
+
+#include <Eigen/Dense>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace jwm
+{
+    namespace detail
+    {
+        inline std::system_error errno_error(std::string const &what)
+        {
+            return std::system_error(errno, std::generic_category(), what);
+        }
+
+
+        // Parse a kernel CPU list such as "0-3,8,10-11".
+        inline std::vector<int> parse_cpulist(std::string const &s)
+        {
+            std::vector<int> result;
+            std::size_t i = 0;
+            while (i < s.size())
+            {
+                std::size_t end;
+                int const first = std::stoi(s.substr(i), &end);
+                i += end;
+                int last = first;
+                if (i < s.size() && s[i] == '-')
+                {
+                    last = std::stoi(s.substr(++i), &end);
+                    i += end;
+                }
+                for (int cpu = first; cpu <= last; ++cpu)
+                    result.push_back(cpu);
+                while (i < s.size() && (s[i] == ',' || s[i] == '\n'))
+                    ++i;
+            }
+            return result;
+        }
+
+
+        // The CPUs of each online NUMA node.  Empty if the machine does not
+        // say, in which case workers are not pinned.
+        inline std::vector<std::vector<int>> numa_nodes()
+        {
+            std::vector<std::vector<int>> result;
+            std::ifstream online("/sys/devices/system/node/online");
+            std::string nodes;
+            if (!std::getline(online, nodes))
+                return result;
+            for (int const node : parse_cpulist(nodes))
+            {
+                std::ifstream f("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+                std::string cpus;
+                if (std::getline(f, cpus) && !cpus.empty())
+                    result.push_back(parse_cpulist(cpus));
+            }
+            return result;
+        }
+
+
+        inline void pin_to(std::vector<int> const &cpus)
+        {
+            if (cpus.empty())
+                return;
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int const cpu : cpus)
+                CPU_SET(cpu, &set);
+            sched_setaffinity(0, sizeof(set), &set); // Best effort: cgroups may forbid it.
+        }
+
+
+        // A read-only private mapping of a whole column file.
+        template <typename T>
+        class mapped_column
+        {
+            void *p = MAP_FAILED;
+            std::size_t bytes = 0;
+
+        public:
+            explicit mapped_column(std::string const &path)
+            {
+                int const fd = ::open(path.c_str(), O_RDONLY);
+                if (fd == -1)
+                    throw errno_error(path);
+                struct stat s;
+                if (::fstat(fd, &s) != 0)
+                {
+                    auto const e = errno_error(path);
+                    ::close(fd);
+                    throw e;
+                }
+                if (s.st_size == 0)
+                {
+                    ::close(fd);
+                    throw std::invalid_argument(path + ": empty column");
+                }
+                bytes = std::size_t(s.st_size);
+                p = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+                auto const e = errno_error(path);
+                ::close(fd);
+                if (p == MAP_FAILED)
+                    throw e;
+                ::madvise(p, bytes, MADV_SEQUENTIAL);
+            }
+
+            mapped_column(mapped_column const &) = delete;
+            mapped_column &operator=(mapped_column const &) = delete;
+
+            mapped_column(mapped_column &&x) noexcept : p(x.p), bytes(x.bytes)
+            {
+                x.p = MAP_FAILED;
+            }
+
+            ~mapped_column()
+            {
+                if (p != MAP_FAILED)
+                    ::munmap(p, bytes);
+            }
+
+            T const *data() const { return static_cast<T const *>(p); }
+            std::size_t size() const { return bytes / sizeof(T); }
+            std::size_t bytes_size() const { return bytes; }
+        };
+
+
+        // Map every column, checking that they all have the same length.
+        template <typename T>
+        std::vector<mapped_column<T>> map_columns(std::vector<std::string> const &columns)
+        {
+            if (columns.empty())
+                throw std::invalid_argument("no columns");
+            std::vector<mapped_column<T>> result;
+            for (auto const &column : columns)
+            {
+                result.emplace_back(column);
+                if (result.back().bytes_size() % sizeof(T) != 0 || result.back().bytes_size() != result.front().bytes_size())
+                    throw std::invalid_argument(column + ": column length mismatch");
+            }
+            return result;
+        }
+
+
+        inline void write_all(int fd, char const *p, std::size_t n)
+        {
+            while (n != 0)
+            {
+                auto const k = ::write(fd, p, n);
+                if (k == -1 && errno == EINTR)
+                    continue;
+                if (k <= 0)
+                    throw errno_error("write");
+                p += k;
+                n -= std::size_t(k);
+            }
+        }
+
+
+        inline std::vector<char> read_all(int fd)
+        {
+            std::vector<char> result;
+            char buffer[4096];
+            for (;;)
+            {
+                auto const k = ::read(fd, buffer, sizeof(buffer));
+                if (k == -1 && errno == EINTR)
+                    continue;
+                if (k == -1)
+                    throw errno_error("read");
+                if (k == 0)
+                    return result;
+                result.insert(result.end(), buffer, buffer + k);
+            }
+        }
+
+
+        /**
+         * Fork `workers` processes, the i-th pinned to NUMA node i mod the
+         * number of nodes, and run f(first, last) in it for its share of
+         * [0, n).  f returns the serialized partial result, which is
+         * returned here in worker order.  If f throws, the worker sends
+         * what() instead and exits with status 1, and this throws
+         * std::runtime_error with that message.
+         *
+         * Precondition: the calling process is single-threaded.
+         */
+        template <typename F>
+        std::vector<std::vector<char>> map_partitions(std::size_t n, unsigned workers, F f)
+        {
+            auto const nodes = numa_nodes();
+            if (workers == 0)
+                workers = std::max(1u, std::thread::hardware_concurrency());
+            workers = unsigned(std::min<std::size_t>(workers, n));
+
+            std::vector<pid_t> pids;
+            std::vector<int> fds;
+            // Close the pipes and wait for every worker; true if all of them
+            // exited with status 0.
+            auto const reap = [&]()
+            {
+                for (int const fd : fds)
+                    ::close(fd);
+                fds.clear();
+                std::vector<bool> ok;
+                for (pid_t const pid : pids)
+                {
+                    int status = 0;
+                    pid_t r;
+                    while ((r = ::waitpid(pid, &status, 0)) == -1 && errno == EINTR)
+                        ;
+                    ok.push_back(r == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+                }
+                pids.clear();
+                return ok;
+            };
+
+            for (unsigned i = 0; i != workers; ++i)
+            {
+                int pipe[2];
+                if (::pipe(pipe) != 0)
+                {
+                    auto const e = errno_error("pipe");
+                    reap();
+                    throw e;
+                }
+                pid_t const pid = ::fork();
+                if (pid == -1)
+                {
+                    auto const e = errno_error("fork");
+                    ::close(pipe[0]);
+                    ::close(pipe[1]);
+                    reap();
+                    throw e;
+                }
+                if (pid == 0)
+                {
+                    ::close(pipe[0]);
+                    int status = 0;
+                    try
+                    {
+                        if (!nodes.empty())
+                            pin_to(nodes[i % nodes.size()]);
+                        auto const first = n * i / workers, last = n * (i + 1) / workers;
+                        auto const bytes = f(first, last);
+                        write_all(pipe[1], bytes.data(), bytes.size());
+                    }
+                    catch (std::exception const &e)
+                    {
+                        status = 1;
+                        try { write_all(pipe[1], e.what(), std::strlen(e.what())); } catch (...) {}
+                    }
+                    catch (...)
+                    {
+                        status = 1;
+                    }
+                    ::_exit(status);
+                }
+                ::close(pipe[1]);
+                pids.push_back(pid);
+                fds.push_back(pipe[0]);
+            }
+
+            std::vector<std::vector<char>> result;
+            try
+            {
+                for (int const fd : fds)
+                    result.push_back(read_all(fd));
+            }
+            catch (...)
+            {
+                reap();
+                throw;
+            }
+            auto const ok = reap();
+            for (std::size_t i = 0; i != ok.size(); ++i)
+                if (!ok[i])
+                    throw std::runtime_error("correlation worker " + std::to_string(i) + " failed: " + std::string(result[i].begin(), result[i].end()));
+            return result;
+        }
+
+
+        template <typename T>
+        void append(std::vector<char> &bytes, T const *p, std::size_t n)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "");
+            auto const q = reinterpret_cast<char const *>(p);
+            bytes.insert(bytes.end(), q, q + n * sizeof(T));
+        }
+
+
+        template <typename T>
+        char const *extract(char const *bytes, T *p, std::size_t n)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "");
+            std::memcpy(p, bytes, n * sizeof(T));
+            return bytes + n * sizeof(T);
+        }
+    }
+
+
+    // The multivariate counterpart of comoments: the size, the column means
+    // and the matrix of centred sums of products of a sample.
+    template <typename T>
+    struct comoment_matrix
+    {
+        using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+        using Matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+
+        std::ptrdiff_t n;
+        Vector mean;
+        Matrix C;
+    };
+
+
+    template <typename T>
+    comoment_matrix<T> merge(comoment_matrix<T> const &a, comoment_matrix<T> const &b)
+    {
+        if (a.n == 0)
+            return b;
+        if (b.n == 0)
+            return a;
+        auto const n = a.n + b.n;
+        typename comoment_matrix<T>::Vector const d = b.mean - a.mean;
+        T const w = T(a.n) * T(b.n) / T(n);
+        return comoment_matrix<T>{n, a.mean + d * (T(b.n) / T(n)), a.C + b.C + w * d * d.transpose()};
+    }
+
+
+    /**
+     * Correlate two column files with a pool of worker processes; workers == 0
+     * means one per CPU.  Each worker summarizes its rows with
+     * make_comoments and the partials are merged into the same
+     * (r, mean_x, mean_y) that Pearson_correlation_coefficient returns.
+     *
+     * Must be called while the process is single-threaded, since the
+     * workers are forked.  Missing or unmappable files throw
+     * std::system_error, columns of different or zero length
+     * std::invalid_argument.
+     */
+    template <typename T = double>
+    std::tuple<T, T, T> Pearson_correlation_coefficient_files(std::string const &x, std::string const &y, unsigned workers = 0)
+    {
+        static_assert(std::is_trivially_copyable<comoments<T>>::value, "");
+        auto const cs = detail::map_columns<T>({x, y});
+        auto const n = cs.front().size();
+        auto const partials = detail::map_partitions(n, workers, [&](std::size_t first, std::size_t last)
+        {
+            auto const m = make_comoments(cs[0].data() + first, cs[0].data() + last, cs[1].data() + first);
+            std::vector<char> bytes;
+            detail::append(bytes, &m, 1);
+            return bytes;
+        });
+
+        comoments<T> m{0, T{0}, T{0}, T{0}, T{0}, T{0}};
+        for (auto const &bytes : partials)
+        {
+            if (bytes.size() != sizeof(m))
+                throw std::runtime_error("truncated correlation partial");
+            comoments<T> partial;
+            detail::extract(bytes.data(), &partial, 1);
+            m = merge(m, partial);
+        }
+        return Pearson_correlation_coefficient(m);
+    }
+
+
+    /**
+     * The correlation matrix of k column files and their means, computed
+     * like Pearson_correlation_coefficient_files and with the same
+     * precondition and errors.  Each worker centres its rows chunk rows at
+     * a time and accumulates the cross products with one matrix product per
+     * chunk.
+     */
+    template <typename T = double>
+    auto correlation_matrix_files(std::vector<std::string> const &columns, unsigned workers = 0, std::ptrdiff_t chunk = 4096)
+    {
+        assert(chunk > 0);
+        using Vector = typename comoment_matrix<T>::Vector;
+        using Matrix = typename comoment_matrix<T>::Matrix;
+        auto const cs = detail::map_columns<T>(columns);
+        auto const n = cs.front().size();
+        auto const k = std::ptrdiff_t(columns.size());
+
+        auto const partials = detail::map_partitions(n, workers, [&](std::size_t first, std::size_t last)
+        {
+            Eigen::setNbThreads(1); // OpenMP is not safe to start after fork.
+            auto const m = std::ptrdiff_t(last - first);
+
+            Vector mean(k);
+            for (std::ptrdiff_t j = 0; j != k; ++j)
+                mean[j] = Eigen::Map<Vector const>(cs[j].data() + first, m).mean();
+
+            Matrix C = Matrix::Zero(k, k), block(chunk, k);
+            for (std::ptrdiff_t r = 0; r < m; r += chunk)
+            {
+                auto const rows = std::min(chunk, m - r);
+                for (std::ptrdiff_t j = 0; j != k; ++j)
+                    block.col(j).head(rows) = Eigen::Map<Vector const>(cs[j].data() + first + r, rows).array() - mean[j];
+                C.noalias() += block.topRows(rows).transpose() * block.topRows(rows);
+            }
+
+            std::int64_t const size = m;
+            std::vector<char> bytes;
+            detail::append(bytes, &size, 1);
+            detail::append(bytes, mean.data(), std::size_t(k));
+            detail::append(bytes, C.data(), std::size_t(k * k));
+            return bytes;
+        });
+
+        comoment_matrix<T> total{0, Vector::Zero(k), Matrix::Zero(k, k)};
+        for (auto const &bytes : partials)
+        {
+            if (bytes.size() != sizeof(std::int64_t) + std::size_t(k + k * k) * sizeof(T))
+                throw std::runtime_error("truncated correlation partial");
+            std::int64_t size;
+            comoment_matrix<T> partial{0, Vector(k), Matrix(k, k)};
+            auto p = detail::extract(bytes.data(), &size, 1);
+            p = detail::extract(p, partial.mean.data(), std::size_t(k));
+            detail::extract(p, partial.C.data(), std::size_t(k * k));
+            partial.n = size;
+            total = merge(total, partial);
+        }
+
+        Vector const s = total.C.diagonal().cwiseSqrt();
+        Matrix const R = total.C.array() / (s * s.transpose()).array();
+        return std::make_tuple(R, total.mean);
+    }
+}
+
+#endif
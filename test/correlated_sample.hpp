@@ -0,0 +1,24 @@
+#ifndef JWM_TEST_CORRELATED_SAMPLE_HPP
+#define JWM_TEST_CORRELATED_SAMPLE_HPP
+
+#include <cstddef>
+#include <random>
+#include <vector>
+
+// n pairs with y = x + noise, both standard normal, so that r is about
+// 0.707 and well defined.  Shared by the tests and the benchmarks.
+template <typename T>
+void correlated_sample(std::vector<T> &x, std::vector<T> &y, std::size_t n)
+{
+    std::mt19937_64 g(42);
+    std::normal_distribution<T> d;
+    x.resize(n);
+    y.resize(n);
+    for (std::size_t i = 0; i != n; ++i)
+    {
+        x[i] = d(g);
+        y[i] = x[i] + d(g);
+    }
+}
+
+#endif
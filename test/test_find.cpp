@@ -17,35 +17,35 @@ ostream &operator<<(ostream &os, Iterator it)
 }
 
 
-vector<int> const data = {0, 1, 2, 3, 4};
+vector<int> const xs = {0, 1, 2, 3, 4};
 
 TEST(find, predicate)
 {
     auto const pred = bind(greater<>(), placeholders::_1, 2);
-    auto const y = find_if_unguarded(begin(data), pred);
-    ASSERT_EQ(begin(data) + 3, y);
+    auto const y = find_if_unguarded(begin(xs), pred);
+    ASSERT_EQ(begin(xs) + 3, y);
 }
 
 
 TEST(find, rvalue)
 {
     int x = 1;
-    auto const y = find_unguarded(begin(data), move(x));
-    ASSERT_EQ(find(begin(data), end(data), move(x)), y);
+    auto const y = find_unguarded(begin(xs), move(x));
+    ASSERT_EQ(find(begin(xs), end(xs), move(x)), y);
 }
 
 
 TEST(find, lvalue)
 {
     int x = 1;
-    auto const y = find_unguarded(begin(data), x);
-    ASSERT_EQ(find(begin(data), end(data), x), y);
+    auto const y = find_unguarded(begin(xs), x);
+    ASSERT_EQ(find(begin(xs), end(xs), x), y);
 }
 
 
 TEST(find, const_lvalue)
 {
     int const x = 1;
-    auto const y = find_unguarded(begin(data), x);
-    ASSERT_EQ(find(begin(data), end(data), x), y);
+    auto const y = find_unguarded(begin(xs), x);
+    ASSERT_EQ(find(begin(xs), end(xs), x), y);
 }
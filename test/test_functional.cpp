@@ -30,3 +30,53 @@ TEST(identity, rvalue)
     auto const &y = id(std::move(x));
     ASSERT_EQ(x, y);
 }
+
+
+TEST(bind1st, minus)
+{
+    auto const f = bind1st(std::minus<>(), 10);
+    ASSERT_EQ(7, f(3));
+}
+
+
+TEST(bind2nd, minus)
+{
+    auto const f = bind2nd(std::minus<>(), 10);
+    ASSERT_EQ(-7, f(3));
+}
+
+
+TEST(bind2nd, lvalue)
+{
+    int x = 1;
+    auto const f = bind2nd(std::equal_to<>(), x);
+    x = 2;
+    EXPECT_TRUE(f(1)); // x is bound by value, as with std::bind.
+}
+
+
+TEST(bind2nd, empty_base)
+{
+    using binder = decltype(bind2nd(std::minus<>(), 0.0));
+    static_assert(sizeof(binder) == sizeof(double), "");
+    static_assert(noexcept(std::declval<binder const &>()(1.0)), "");
+    constexpr auto f = bind2nd(std::minus<>(), 1);
+    static_assert(f(3) == 2, "");
+}
+
+
+TEST(compose, negate_minus)
+{
+    auto const f = compose(std::negate<>(), bind2nd(std::minus<>(), 10));
+    static_assert(sizeof(f) == sizeof(int), "");
+    ASSERT_EQ(7, f(3));
+}
+
+
+TEST(compose, same_empty_type)
+{
+    constexpr auto f = compose(std::negate<>(), std::negate<>());
+    static_assert(std::is_empty<std::decay_t<decltype(f)>>::value, "");
+    static_assert(f(3) == 3, "");
+    ASSERT_EQ(3, f(3));
+}
@@ -0,0 +1,107 @@
+#include "../partitioned_correlation.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace jwm;
+using namespace std;
+
+
+vector<vector<double>> const columns = {{43, 21, 25, 42, 57, 59, 33},
+                                        {99, 65, 79, 75, 87, 81, 70},
+                                        {-3, 12, 7, 0, -9, -14, 2}};
+
+
+// Writes columns to temporary files and removes them again.
+struct column_files
+{
+    vector<string> paths;
+
+    explicit column_files(vector<vector<double>> const &data)
+    {
+        for (size_t j = 0; j != data.size(); ++j)
+        {
+            paths.push_back(::testing::TempDir() + "jwm_column_" + to_string(::getpid()) + "_" + to_string(j));
+            ofstream f(paths.back(), ios::binary);
+            f.write(reinterpret_cast<char const *>(data[j].data()), data[j].size() * sizeof(double));
+        }
+    }
+
+    ~column_files()
+    {
+        for (auto const &path : paths)
+            remove(path.c_str());
+    }
+};
+
+
+TEST(partitioned_correlation, pair)
+{
+    column_files const files(columns);
+    auto const exact = Pearson_correlation_coefficient(begin(columns[0]), end(columns[0]), begin(columns[1]));
+    for (unsigned workers : {1u, 3u, 8u})
+    {
+        auto const r = Pearson_correlation_coefficient_files(files.paths[0], files.paths[1], workers);
+        EXPECT_NEAR(get<0>(exact), get<0>(r), 1e-12);
+        EXPECT_NEAR(get<1>(exact), get<1>(r), 1e-12);
+        EXPECT_NEAR(get<2>(exact), get<2>(r), 1e-12);
+    }
+}
+
+
+TEST(partitioned_correlation, matrix)
+{
+    column_files const files(columns);
+    auto const r = correlation_matrix_files(files.paths, 3, 2);
+    auto const &R = get<0>(r);
+    auto const &mean = get<1>(r);
+    ASSERT_EQ(3, R.rows());
+    ASSERT_EQ(3, R.cols());
+    for (size_t i = 0; i != columns.size(); ++i)
+    {
+        EXPECT_NEAR(1.0, R(i, i), 1e-12);
+        for (size_t j = 0; j != columns.size(); ++j)
+        {
+            auto const exact = Pearson_correlation_coefficient(begin(columns[i]), end(columns[i]), begin(columns[j]));
+            EXPECT_NEAR(get<0>(exact), R(i, j), 1e-12);
+            EXPECT_NEAR(get<1>(exact), mean[i], 1e-12);
+        }
+    }
+}
+
+
+TEST(partitioned_correlation, errors)
+{
+    vector<vector<double>> data = columns;
+    data[2].push_back(0);
+    data.push_back({});
+    column_files const files(data);
+    EXPECT_THROW(Pearson_correlation_coefficient_files(files.paths[0], files.paths[2]), invalid_argument);
+    EXPECT_THROW(Pearson_correlation_coefficient_files(files.paths[0], files.paths[3]), invalid_argument);
+    EXPECT_THROW(Pearson_correlation_coefficient_files(files.paths[0], files.paths[0] + ".missing"), system_error);
+}
+
+
+TEST(map_partitions, worker_error)
+{
+    try
+    {
+        detail::map_partitions(4, 2, [](size_t, size_t) -> vector<char> { throw invalid_argument("boom"); });
+        FAIL();
+    }
+    catch (runtime_error const &e)
+    {
+        EXPECT_NE(string::npos, string(e.what()).find("boom"));
+    }
+}
+
+
+TEST(parse_cpulist, ranges)
+{
+    vector<int> const expected = {0, 1, 2, 3, 8, 10, 11};
+    EXPECT_EQ(expected, detail::parse_cpulist("0-3,8,10-11\n"));
+}
@@ -1,8 +1,12 @@
 #include "../Pearson_correlation_coefficient.hpp"
+#include "correlated_sample.hpp"
 
 #include <gtest/gtest.h>
 
 #include <cmath>
+#include <list>
+#include <random>
+#include <vector>
 
 using namespace jwm;
 using namespace std;
@@ -40,3 +44,242 @@ TEST(Pearson_correlation_coefficient, StatisticsHowTo)
     auto r = Pearson_correlation_coefficient_concrete_one_pass_Kahan(begin(x), end(x), begin(y));
     ASSERT_NEAR(0.529809, get<0>(r), 0.000001);
 }
+
+
+TEST(inner_product_nonempty, contiguous_matches_generic)
+{
+    vector<double> const x = {43, 21, 25, 42, 57, 59},
+                         y = {99, 65, 79, 75, 87, 81};
+    list<double> const lx(begin(x), end(x)), ly(begin(y), end(y));
+    auto const fx = make_transform_iterator(begin(x), bind2nd(minus<>(), 41.0));
+    auto const flx = make_transform_iterator(begin(lx), bind2nd(minus<>(), 41.0));
+    auto const fast = inner_product_nonempty(fx, fx + x.size(), begin(y));
+    auto const slow = inner_product_nonempty(flx, make_transform_iterator(end(lx), bind2nd(minus<>(), 41.0)), begin(ly));
+    ASSERT_DOUBLE_EQ(slow, fast);
+}
+
+
+TEST(three_way_inner_product, contiguous_matches_generic)
+{
+    vector<double> const x = {43, 21, 25, 42, 57, 59},
+                         y = {99, 65, 79, 75, 87, 81};
+    list<double> const lx(begin(x), end(x)), ly(begin(y), end(y));
+    auto const fast = three_way_inner_product(begin(x), end(x), begin(y), 0.0, 0.0, 0.0);
+    auto const slow = three_way_inner_product(begin(lx), end(lx), begin(ly), 0.0, 0.0, 0.0);
+    EXPECT_DOUBLE_EQ(get<0>(slow), get<0>(fast));
+    EXPECT_DOUBLE_EQ(get<1>(slow), get<1>(fast));
+    EXPECT_DOUBLE_EQ(get<2>(slow), get<2>(fast));
+}
+
+
+TEST(three_way_inner_product, contiguous_matches_generic_float)
+{
+    // float products summed in double: the fast path must round each
+    // product to float just as std::multiplies<> does.
+    vector<float> const x = {0.1f, 1.7f, 3.3f, 2.9f},
+                        y = {0.3f, 2.2f, 0.7f, 5.1f};
+    list<float> const lx(begin(x), end(x)), ly(begin(y), end(y));
+    auto const fast = three_way_inner_product(begin(x), end(x), begin(y), 0.0, 0.0, 0.0);
+    auto const slow = three_way_inner_product(begin(lx), end(lx), begin(ly), 0.0, 0.0, 0.0);
+    EXPECT_EQ(slow, fast);
+}
+
+
+TEST(three_way_inner_product, contiguous_empty)
+{
+    vector<double> const x;
+    auto const r = three_way_inner_product(begin(x), end(x), begin(x), 1.0, 2.0, 3.0);
+    EXPECT_EQ(make_tuple(1.0, 2.0, 3.0), r);
+}
+
+
+TEST(Pearson_correlation_coefficient, variants_agree)
+{
+    vector<double> const x = {43, 21, 25, 42, 57, 59},
+                         y = {99, 65, 79, 75, 87, 81};
+    auto const r = Pearson_correlation_coefficient(begin(x), end(x), begin(y));
+    ASSERT_NEAR(0.529809, get<0>(r), 0.000001);
+    auto const mean_x = get<1>(r), mean_y = get<2>(r);
+    EXPECT_DOUBLE_EQ(get<0>(r), Pearson_correlation_coefficient_concrete(begin(x), end(x), begin(y), mean_x, mean_y));
+    EXPECT_DOUBLE_EQ(get<0>(r), Pearson_correlation_coefficient_ba(begin(x), end(x), begin(y), mean_x, mean_y));
+    EXPECT_DOUBLE_EQ(get<0>(r), Pearson_correlation_coefficient_d(begin(x), end(x), begin(y), mean_x, mean_y));
+    EXPECT_DOUBLE_EQ(get<0>(r), Pearson_correlation_coefficient_eigen(begin(x), end(x), begin(y), mean_x, mean_y));
+}
+
+
+TEST(Pearson_correlation_coefficient, Eigen_columns)
+{
+    Eigen::MatrixXd m(6, 2);
+    m << 43, 99,
+         21, 65,
+         25, 79,
+         42, 75,
+         57, 87,
+         59, 81;
+    auto const r = Pearson_correlation_coefficient(m.col(0), m.col(1));
+    ASSERT_NEAR(0.529809, get<0>(r), 0.000001);
+    EXPECT_DOUBLE_EQ(41.166666666666667, get<1>(r));
+    EXPECT_DOUBLE_EQ(81.0, get<2>(r));
+}
+
+
+TEST(Pearson_correlation_coefficient, Eigen_rows)
+{
+    Eigen::Matrix<double, 2, Eigen::Dynamic, Eigen::RowMajor> m(2, 6);
+    m << 43, 21, 25, 42, 57, 59,
+         99, 65, 79, 75, 87, 81;
+    auto const r = Pearson_correlation_coefficient(m.row(0), m.row(1));
+    ASSERT_NEAR(0.529809, get<0>(r), 0.000001);
+
+    Eigen::MatrixXd const n = m; // column-major, so rows are strided.
+    auto const s = Pearson_correlation_coefficient(n.row(0), n.row(1));
+    EXPECT_DOUBLE_EQ(get<0>(r), get<0>(s));
+
+    Eigen::VectorXd const y = m.row(1).transpose();
+    auto const t = Pearson_correlation_coefficient(m.row(0), y);
+    EXPECT_DOUBLE_EQ(get<0>(r), get<0>(t));
+}
+
+
+TEST(Pearson_correlation_coefficient, Eigen_strided_Map)
+{
+    vector<double> const xy = {43, 99, 21, 65, 25, 79, 42, 75, 57, 87, 59, 81};
+    using Strided = Eigen::Map<Eigen::VectorXd const, 0, Eigen::InnerStride<2>>;
+    Strided const x(xy.data(), 6), y(xy.data() + 1, 6);
+    auto const r = Pearson_correlation_coefficient(x, y);
+    ASSERT_NEAR(0.529809, get<0>(r), 0.000001);
+}
+
+
+TEST(columnwise_Pearson_correlation_coefficient, StatisticsHowTo)
+{
+    Eigen::MatrixXd X(6, 2);
+    X << 43, -43,
+         21, -21,
+         25, -25,
+         42, -42,
+         57, -57,
+         59, -59;
+    Eigen::VectorXd y(6);
+    y << 99, 65, 79, 75, 87, 81;
+    auto const r = columnwise_Pearson_correlation_coefficient(X, Eigen::Ref<Eigen::VectorXd const>(y));
+    Eigen::RowVectorXd const y_row = y.transpose();
+    auto const s = columnwise_Pearson_correlation_coefficient(X, Eigen::Map<Eigen::RowVectorXd const>(y_row.data(), 6));
+    EXPECT_TRUE(get<0>(r).isApprox(get<0>(s)));
+    ASSERT_EQ(2, get<0>(r).size());
+    EXPECT_NEAR(0.529809, get<0>(r)[0], 0.000001);
+    EXPECT_NEAR(-0.529809, get<0>(r)[1], 0.000001);
+    EXPECT_DOUBLE_EQ(-get<1>(r)[0], get<1>(r)[1]);
+    EXPECT_DOUBLE_EQ(81.0, get<2>(r));
+}
+
+
+TEST(Pearson_correlation_coefficient_interleaved, StatisticsHowTo)
+{
+    vector<double> const xy = {43, 99, 21, 65, 25, 79, 42, 75, 57, 87, 59, 81};
+    auto const r = Pearson_correlation_coefficient_interleaved(begin(xy), end(xy));
+    ASSERT_NEAR(0.529809, get<0>(r), 0.000001);
+    EXPECT_DOUBLE_EQ(41.166666666666667, get<1>(r));
+    EXPECT_DOUBLE_EQ(81.0, get<2>(r));
+}
+
+
+TEST(Pearson_correlation_coefficient_interleaved, stride)
+{
+    // Each record carries a third field that must be skipped.
+    vector<double> const xyz = {43, 99, 0, 21, 65, 1, 25, 79, 2, 42, 75, 3, 57, 87, 4, 59, 81, 5};
+    auto const r = Pearson_correlation_coefficient_interleaved(begin(xyz), end(xyz), 3);
+    ASSERT_NEAR(0.529809, get<0>(r), 0.000001);
+}
+
+
+TEST(Pearson_correlation_coefficient, member_pointers)
+{
+    vector<pair<double, double>> const xy = {{43, 99}, {21, 65}, {25, 79}, {42, 75}, {57, 87}, {59, 81}};
+    using P = pair<double, double>;
+    auto const r = Pearson_correlation_coefficient(begin(xy), end(xy), &P::first, &P::second);
+    ASSERT_NEAR(0.529809, get<0>(r), 0.000001);
+    auto const s = Pearson_correlation_coefficient(begin(xy), end(xy), &P::second, &P::first);
+    EXPECT_DOUBLE_EQ(get<0>(r), get<0>(s));
+}
+
+
+TEST(comoments, merge)
+{
+    vector<double> const x = {43, 21, 25, 42, 57, 59},
+                         y = {99, 65, 79, 75, 87, 81};
+    auto const whole = make_comoments(begin(x), end(x), begin(y));
+    auto const parts = merge(make_comoments(begin(x), begin(x) + 2, begin(y)),
+                             make_comoments(begin(x) + 2, end(x), begin(y) + 2));
+    ASSERT_EQ(whole.n, parts.n);
+    EXPECT_DOUBLE_EQ(whole.mean_x, parts.mean_x);
+    EXPECT_DOUBLE_EQ(whole.mean_y, parts.mean_y);
+    EXPECT_DOUBLE_EQ(whole.xx, parts.xx);
+    EXPECT_DOUBLE_EQ(whole.xy, parts.xy);
+    EXPECT_DOUBLE_EQ(whole.yy, parts.yy);
+    ASSERT_NEAR(0.529809, get<0>(Pearson_correlation_coefficient(parts)), 0.000001);
+}
+
+
+TEST(Pearson_correlation_coefficient_approximate, early_termination)
+{
+    vector<double> x, y;
+    correlated_sample(x, y, 1 << 20);
+    mt19937_64 g(1);
+    auto const exact = Pearson_correlation_coefficient(begin(x), end(x), begin(y));
+    auto const r = Pearson_correlation_coefficient_approximate(begin(x), end(x), begin(y), 0.01, g);
+    EXPECT_LT(get<3>(r), ptrdiff_t(x.size()));
+    EXPECT_NEAR(get<0>(exact), get<0>(r), 0.01);
+}
+
+
+TEST(Pearson_correlation_coefficient_approximate, exhaustive)
+{
+    vector<double> x, y;
+    correlated_sample(x, y, 1 << 20);
+    mt19937_64 g(1);
+    auto const exact = Pearson_correlation_coefficient(begin(x), end(x), begin(y));
+    auto const r = Pearson_correlation_coefficient_approximate(begin(x), end(x), begin(y), 0, g);
+    ASSERT_EQ(ptrdiff_t(x.size()), get<3>(r));
+    EXPECT_NEAR(get<0>(exact), get<0>(r), 1e-12);
+    EXPECT_NEAR(get<1>(exact), get<1>(r), 1e-12);
+    EXPECT_NEAR(get<2>(exact), get<2>(r), 1e-12);
+}
+
+
+TEST(Pearson_correlation_coefficient_approximate, float)
+{
+    vector<float> x, y;
+    correlated_sample(x, y, 1 << 20);
+    mt19937_64 g(1);
+    auto const r = Pearson_correlation_coefficient_approximate(begin(x), end(x), begin(y), 0.01, g);
+    static_assert(is_same<tuple<float, float, float, ptrdiff_t>, decay_t<decltype(r)>>::value, "");
+    EXPECT_LT(get<3>(r), ptrdiff_t(x.size()));
+    EXPECT_NEAR(0.7071, get<0>(r), 0.01);
+}
+
+
+TEST(Pearson_correlation_coefficient_approximate, small_input_is_exact)
+{
+    vector<double> const x = {43, 21, 25, 42, 57, 59},
+                         y = {99, 65, 79, 75, 87, 81};
+    mt19937_64 g(1);
+    auto const r = Pearson_correlation_coefficient_approximate(begin(x), end(x), begin(y), 0.5, g);
+    ASSERT_EQ(6, get<3>(r));
+    ASSERT_NEAR(0.529809, get<0>(r), 0.000001);
+}
+
+
+TEST(Pearson_correlation_coefficient_approximate, pointer_y)
+{
+    vector<double> x, y;
+    correlated_sample(x, y, 1 << 20);
+    mt19937_64 g(1);
+    auto const exact = Pearson_correlation_coefficient(begin(x), end(x), begin(y));
+    auto const r = Pearson_correlation_coefficient_approximate(begin(x), end(x), y.data(), 0, g);
+    EXPECT_NEAR(get<0>(exact), get<0>(r), 1e-12);
+    auto const small = Pearson_correlation_coefficient_approximate(begin(x), begin(x) + 6, y.data(), 0.5, g);
+    ASSERT_EQ(6, get<3>(small));
+    auto const small_exact = Pearson_correlation_coefficient(begin(x), begin(x) + 6, begin(y));
+    EXPECT_NEAR(get<0>(small_exact), get<0>(small), 1e-12);
+}
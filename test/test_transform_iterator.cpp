@@ -0,0 +1,52 @@
+#include "../transform_iterator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <vector>
+
+using namespace jwm;
+using namespace std;
+
+
+static_assert(is_contiguous_iterator<int *>::value, "");
+static_assert(is_contiguous_iterator<vector<int>::const_iterator>::value, "");
+static_assert(is_contiguous_iterator<array<int, 3>::iterator>::value, "");
+static_assert(!is_contiguous_iterator<list<int>::iterator>::value, "");
+static_assert(!is_contiguous_iterator<vector<bool>::iterator>::value, "");
+
+
+TEST(transform_iterator, random_access)
+{
+    vector<int> const x = {1, 2, 3, 4};
+    auto const f = make_transform_iterator(begin(x), bind2nd(minus<>(), 1));
+    auto const l = f + x.size();
+    ASSERT_EQ(4, l - f);
+    EXPECT_EQ(0, *f);
+    EXPECT_EQ(2, f[2]);
+    EXPECT_EQ(3, *prev(l));
+    EXPECT_EQ(begin(x) + 1, next(f).base());
+}
+
+
+TEST(transform_iterator, contiguous_view)
+{
+    vector<double> const x = {1, 2, 3};
+    auto const f = make_transform_iterator(make_transform_iterator(begin(x), bind2nd(minus<>(), 1.0)), negate<>());
+    static_assert(is_contiguous_view_source<decay_t<decltype(f)>>::value, "");
+    auto const v = make_contiguous_view(f);
+    ASSERT_EQ(x.data(), v.p);
+    EXPECT_EQ(-2.0, v.f(v.p[2]));
+}
+
+
+TEST(transform_iterator, non_contiguous)
+{
+    list<int> const x = {1, 2, 3};
+    auto const f = make_transform_iterator(begin(x), negate<>());
+    static_assert(!is_contiguous_view_source<decay_t<decltype(f)>>::value, "");
+    EXPECT_EQ(-2, *next(f));
+}
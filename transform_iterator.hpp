@@ -0,0 +1,128 @@
+#ifndef JWM_TRANSFORM_ITERATOR_HPP
+#define JWM_TRANSFORM_ITERATOR_HPP
+
+#include "functional.hpp"
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jwm
+{
+    // True for iterators whose elements are known to be adjacent in memory.
+    // C++14 has no way to ask, so this recognizes pointers and the iterators
+    // of std::vector and std::array.
+    template <typename I, typename T = typename std::iterator_traits<I>::value_type>
+    struct is_contiguous_iterator : std::integral_constant<bool,
+        std::is_pointer<I>::value ||
+        (!std::is_same<T, bool>::value &&
+         (std::is_same<I, typename std::vector<T>::iterator>::value ||
+          std::is_same<I, typename std::vector<T>::const_iterator>::value)) ||
+        std::is_same<I, typename std::array<T, 1>::iterator>::value ||
+        std::is_same<I, typename std::array<T, 1>::const_iterator>::value>
+    {};
+
+
+    /**
+     * Like boost::transform_iterator, but it exposes its base and function
+     * so that algorithms can look through it to a contiguous range, and it
+     * holds an empty function object at no cost.
+     *
+     * The reference type is a prvalue, so strictly this is only an input
+     * iterator; it claims the base's category so that std::distance and
+     * std::next stay O(1).
+     */
+    template <typename I, typename F>
+    class transform_iterator : private detail::function_storage<F>
+    {
+        I i;
+
+    public:
+        using iterator_type = I;
+        using function_type = F;
+        using reference = decltype(std::declval<F const &>()(*std::declval<I>()));
+        using value_type = std::decay_t<reference>;
+        using difference_type = typename std::iterator_traits<I>::difference_type;
+        using pointer = void;
+        using iterator_category = typename std::iterator_traits<I>::iterator_category;
+
+        constexpr transform_iterator(I i, F f) : detail::function_storage<F>(std::move(f)), i(i) {}
+
+        constexpr I base() const { return i; }
+        constexpr F const &function() const noexcept { return detail::function_storage<F>::function(); }
+
+        constexpr reference operator*() const { return function()(*i); }
+        constexpr reference operator[](difference_type n) const { return function()(i[n]); }
+
+        transform_iterator &operator++() { ++i; return *this; }
+        transform_iterator &operator--() { --i; return *this; }
+        transform_iterator operator++(int) { auto tmp = *this; ++i; return tmp; }
+        transform_iterator operator--(int) { auto tmp = *this; --i; return tmp; }
+        transform_iterator &operator+=(difference_type n) { i += n; return *this; }
+        transform_iterator &operator-=(difference_type n) { i -= n; return *this; }
+
+        friend transform_iterator operator+(transform_iterator x, difference_type n) { return x += n; }
+        friend transform_iterator operator+(difference_type n, transform_iterator x) { return x += n; }
+        friend transform_iterator operator-(transform_iterator x, difference_type n) { return x -= n; }
+        friend difference_type operator-(transform_iterator const &x, transform_iterator const &y) { return x.i - y.i; }
+
+        friend bool operator==(transform_iterator const &x, transform_iterator const &y) { return x.i == y.i; }
+        friend bool operator!=(transform_iterator const &x, transform_iterator const &y) { return x.i != y.i; }
+        friend bool operator<(transform_iterator const &x, transform_iterator const &y) { return x.i < y.i; }
+        friend bool operator>(transform_iterator const &x, transform_iterator const &y) { return x.i > y.i; }
+        friend bool operator<=(transform_iterator const &x, transform_iterator const &y) { return x.i <= y.i; }
+        friend bool operator>=(transform_iterator const &x, transform_iterator const &y) { return x.i >= y.i; }
+    };
+
+
+    template <typename I, typename F>
+    constexpr auto make_transform_iterator(I i, F &&f)
+    {
+        return transform_iterator<I, std::decay_t<F>>(i, std::forward<F>(f));
+    }
+
+
+    // A contiguous range seen through an elementwise function: p[i] is
+    // read as f(p[i]).  This is what the fast paths of the numeric
+    // algorithms actually iterate over.  Only three_way_inner_product and
+    // inner_product_nonempty use it; reductions through std::inner_product
+    // with array or Kahan accumulators (variants d to g) do not.
+    // Only make one from a dereferenceable iterator, i.e. a non-empty range.
+    template <typename T, typename F>
+    struct contiguous_view
+    {
+        T const *p;
+        F f;
+    };
+
+
+    template <typename I>
+    struct is_contiguous_view_source : is_contiguous_iterator<I> {};
+
+    template <typename I, typename F>
+    struct is_contiguous_view_source<transform_iterator<I, F>> : is_contiguous_view_source<I> {};
+
+
+    template <typename I>
+    auto make_contiguous_view(I i)
+    {
+        using T = typename std::iterator_traits<I>::value_type;
+        return contiguous_view<T, identity>{std::addressof(*i), identity()};
+    }
+
+
+    template <typename I, typename F>
+    auto make_contiguous_view(transform_iterator<I, F> i)
+    {
+        auto const v = make_contiguous_view(i.base());
+        using T = std::remove_const_t<std::remove_pointer_t<decltype(v.p)>>;
+        auto const f = compose(i.function(), v.f);
+        return contiguous_view<T, std::decay_t<decltype(f)>>{v.p, f};
+    }
+}
+
+#endif